@@ -0,0 +1,148 @@
+/*
+ * Syscall counting shim for the budget tests, see syscount.sh
+ *
+ * Use with:
+ *	SYSCOUNT_LOG=file LD_PRELOAD=./syscount.so mvatom ...
+ *
+ * Each interesting libc call is appended as one line to the log:
+ *	class<TAB>function<TAB>arg<TAB>arg
+ * The first line is "init" to prove that the shim was loaded at all
+ * (LD_PRELOAD does not work for static binaries).
+ *
+ * Classes are upper case, so they never collide with function names:
+ *	RENAME	rename(), renameat(), renameat2()
+ *	STAT	stat() and fstat() families, access(), readlink()
+ *	DIR	opendir(), fdopendir()
+ *	MKDIR	mkdir(), mkdirat()
+ *	LINK	link(), linkat()
+ *	UNLINK	unlink(), unlinkat(), rmdir()
+ *
+ * This needs no privileges and works without ptrace or seccomp.
+ * It only sees calls which go through the dynamic libc, which is
+ * exactly what mvatom does.  Calls libc makes internally are not seen.
+ *
+ * This Works is placed under the terms of the Copyright Less License,
+ * see file COPYRIGHT.CLL.  USE AT OWN RISK, ABSOLUTELY NO WARRANTY.
+ *
+ * Read: Free as free beer, free speech and free baby.
+ * Ever saw a Copyright on a baby?
+ */
+
+#define _GNU_SOURCE
+
+/* Do not include <sys/stat.h>, older glibc has inline stat() wrappers
+ * there which would clash with the definitions below.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <dirent.h>
+
+struct stat;
+struct stat64;
+struct statx;
+
+static int	logfd = -1;
+
+static void
+note(const char *class, const char *fn, const char *a, const char *b)
+{
+  char	buf[BUFSIZ];
+  int	n, e;
+
+  if (logfd<0)
+    return;
+  e	= errno;
+  n	= snprintf(buf, sizeof buf, "%s\t%s\t%s\t%s\n", class, fn, a ? a : "", b ? b : "");
+  if (n >= (int)sizeof buf)
+    {
+      n		= sizeof buf;
+      buf[n-1]	= '\n';
+    }
+  /* A lost line would make the counts too low, so better fail loudly	*/
+  if (n>0 && write(logfd, buf, n)!=n)
+    {
+      static const char	msg[] = "syscount: cannot write log\n";
+
+      if (write(2, msg, sizeof msg-1)) {}
+      _exit(99);
+    }
+  errno	= e;
+}
+
+static void __attribute__((constructor))
+syscount_init(void)
+{
+  const char	*name;
+
+  if ((name=getenv("SYSCOUNT_LOG"))==0 || !*name)
+    return;
+  logfd	= open(name, O_WRONLY|O_APPEND|O_CREAT|O_CLOEXEC, 0666);
+  note("init", "", "", "");
+}
+
+/* Wrap FN of the given CLASS, which returns TYPE and ERR on error.
+ * A and B are the strings to log (or 0), PROTO is the prototype,
+ * ARGS the argument list to pass on.
+ */
+#define	SHIM_T(TYPE,ERR,CLASS,FN,A,B,PROTO,ARGS)		\
+  TYPE								\
+  FN PROTO							\
+  {								\
+    static TYPE	(*real)PROTO;					\
+								\
+    if (!real)							\
+      real	= (TYPE (*)PROTO)dlsym(RTLD_NEXT, #FN);		\
+    note(CLASS, #FN, A, B);					\
+    if (!real)							\
+      {								\
+        errno	= ENOSYS;					\
+        return ERR;						\
+      }								\
+    return real ARGS;						\
+  }
+
+#define	SHIM(CLASS,FN,A,B,PROTO,ARGS)	SHIM_T(int, -1, CLASS, FN, A, B, PROTO, ARGS)
+
+SHIM("RENAME",	rename,		a, b,	(const char *a, const char *b),					(a, b))
+SHIM("RENAME",	renameat,	a, b,	(int fa, const char *a, int fb, const char *b),			(fa, a, fb, b))
+SHIM("RENAME",	renameat2,	a, b,	(int fa, const char *a, int fb, const char *b, unsigned f),	(fa, a, fb, b, f))
+
+SHIM("STAT",	stat,		a, 0,	(const char *a, struct stat *s),				(a, s))
+SHIM("STAT",	lstat,		a, 0,	(const char *a, struct stat *s),				(a, s))
+SHIM("STAT",	fstatat,	a, 0,	(int fa, const char *a, struct stat *s, int f),			(fa, a, s, f))
+SHIM("STAT",	stat64,		a, 0,	(const char *a, struct stat64 *s),				(a, s))
+SHIM("STAT",	lstat64,	a, 0,	(const char *a, struct stat64 *s),				(a, s))
+SHIM("STAT",	fstatat64,	a, 0,	(int fa, const char *a, struct stat64 *s, int f),		(fa, a, s, f))
+SHIM("STAT",	statx,		a, 0,	(int fa, const char *a, int f, unsigned m, struct statx *s),	(fa, a, f, m, s))
+/* glibc before 2.33 routes the stat() family through these	*/
+SHIM("STAT",	__xstat,	a, 0,	(int v, const char *a, struct stat *s),				(v, a, s))
+SHIM("STAT",	__lxstat,	a, 0,	(int v, const char *a, struct stat *s),				(v, a, s))
+SHIM("STAT",	__fxstatat,	a, 0,	(int v, int fa, const char *a, struct stat *s, int f),		(v, fa, a, s, f))
+SHIM("STAT",	__xstat64,	a, 0,	(int v, const char *a, struct stat64 *s),			(v, a, s))
+SHIM("STAT",	__lxstat64,	a, 0,	(int v, const char *a, struct stat64 *s),			(v, a, s))
+SHIM("STAT",	__fxstatat64,	a, 0,	(int v, int fa, const char *a, struct stat64 *s, int f),	(v, fa, a, s, f))
+SHIM("STAT",	fstat,		0, 0,	(int fd, struct stat *s),					(fd, s))
+SHIM("STAT",	fstat64,	0, 0,	(int fd, struct stat64 *s),					(fd, s))
+SHIM("STAT",	__fxstat,	0, 0,	(int v, int fd, struct stat *s),				(v, fd, s))
+SHIM("STAT",	__fxstat64,	0, 0,	(int v, int fd, struct stat64 *s),				(v, fd, s))
+SHIM("STAT",	access,		a, 0,	(const char *a, int m),						(a, m))
+SHIM("STAT",	faccessat,	a, 0,	(int fa, const char *a, int m, int f),				(fa, a, m, f))
+SHIM_T(ssize_t, -1, "STAT",	readlink,	a, 0,	(const char *a, char *b, size_t n),		(a, b, n))
+SHIM_T(ssize_t, -1, "STAT",	readlinkat,	a, 0,	(int fa, const char *a, char *b, size_t n),	(fa, a, b, n))
+
+SHIM_T(DIR *, 0, "DIR",	opendir,	a, 0,	(const char *a),						(a))
+SHIM_T(DIR *, 0, "DIR",	fdopendir,	0, 0,	(int fd),							(fd))
+
+SHIM("MKDIR",	mkdir,		a, 0,	(const char *a, unsigned m),					(a, m))
+SHIM("MKDIR",	mkdirat,	a, 0,	(int fa, const char *a, unsigned m),				(fa, a, m))
+
+SHIM("LINK",	link,		a, b,	(const char *a, const char *b),					(a, b))
+SHIM("LINK",	linkat,		a, b,	(int fa, const char *a, int fb, const char *b, int f),		(fa, a, fb, b, f))
+
+SHIM("UNLINK",	unlink,		a, 0,	(const char *a),						(a))
+SHIM("UNLINK",	unlinkat,	a, 0,	(int fa, const char *a, int f),					(fa, a, f))
+SHIM("UNLINK",	rmdir,		a, 0,	(const char *a),						(a))
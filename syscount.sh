@@ -0,0 +1,108 @@
+#!/bin/bash
+#
+# Syscall budget tests for mvatom, see file Syscalls
+#
+# Usage: syscount.sh [-v] [Syscalls]
+#
+# Runs each test in a fresh temporary directory with syscount.so preloaded,
+# such that the test can check how many renames, stats etc. a run needed.
+# syscount.so is built from syscount.c into the temporary directory,
+# so this can run from Tests without any Makefile rule and leaves
+# nothing behind in the source tree.  Silent on success.
+#
+# Unlike Tests, RUN only checks the exit code, a message is refused.
+#
+# -v prints the calls of each run, use this to set the budgets.
+#
+# This Works is placed under the terms of the Copyright Less License,
+# see file COPYRIGHT.CLL.  USE AT OWN RISK, ABSOLUTELY NO WARRANTY.
+
+STDOUT() { local e=$?; printf '%q' "$1"; printf ' %q' "${@:2}"; printf '\n'; return $e; }
+STDERR() { STDOUT "$@" >&2; }
+OOPS() { STDERR OOPS: "$@"; exit 23; }
+
+VERBOSE=
+[ .-v = ".$1" ] && { VERBOSE=1; shift; }
+[ 1 -ge $# ] || OOPS "Usage: $(basename "$0") [-v] [Syscalls]"
+
+HERE="$(cd "$(dirname "$0")" && pwd)" || OOPS cannot find myself
+NAME="${1:-Syscalls}"
+TESTS="$(readlink -f "${1:-$HERE/Syscalls}")" || OOPS missing "$NAME"
+TOP="$(mktemp -d)" || OOPS cannot create tmpdir
+trap 'rm -rf "$TOP"' 0
+
+SHIM="$TOP/syscount.so"
+${CC:-cc} -g -Wall -O3 -shared -fPIC -o "$SHIM" "$HERE/syscount.c" -ldl ||
+OOPS cannot build "$SHIM"
+
+export PATH="$HERE:$PATH"
+
+fails=0
+tests=0
+lineno=0
+dir=
+log=
+
+fail()
+{
+printf '%s:%d: %s\n' "$NAME" "$lineno" "$*" >&2
+[ -s "$log" ] && sed 's/^/	| /' "$log" >&2
+let fails++
+}
+
+: count what
+count()
+{
+[ -f "$log" ] || { echo 0; return; }
+awk -F'\t' -vW="$1" '$1==W || $2==W { n++ } END { print n+0 }' "$log"
+}
+
+begin()
+{
+[ -n "$dir" ] && return
+let tests++
+dir="$TOP/$tests"
+log="$TOP/$tests.log"
+mkdir "$dir" || OOPS cannot create "$dir"
+}
+
+end()
+{
+[ -z "$dir" ] || rm -rf "$dir" "$log"
+dir=
+log=
+}
+
+while IFS=$'\t' read -r cmd a b
+do
+	let lineno++
+	case "$cmd" in
+	'')	end; continue;;
+	'#'*)	continue;;
+	esac
+	begin
+	case "$cmd" in
+	file)	echo "$a" > "$dir/$b" || OOPS cannot create "$b";;
+	dir)	mkdir -p "$dir/$a" || OOPS cannot create "$a";;
+	run)	: > "$log"
+		read -ra args <<< "$a"
+		( cd "$dir" && SYSCOUNT_LOG="$log" LD_PRELOAD="$SHIM" exec "${args[@]}" ) </dev/null >/dev/null 2>&1
+		ret=$?
+		grep -q '^init' "$log" || fail "$cmd" "$SHIM" not loaded by: "$a"
+		sed -i '/^init/d' "$log"
+		[ -z "$VERBOSE" ] || { printf '%s:%d: run %s\n' "$NAME" "$lineno" "$a"; sed 's/^/	| /' "$log"; }
+		;;
+	RUN)	[ -z "$b" ] || OOPS "$NAME:$lineno:" RUN message not supported, only the exit code is checked
+		[ ".$a" = ".$ret" ] || fail "$cmd" exit code "$ret", expected "$a";;
+	FILE)	[ -f "$dir/$b" ] && [ ".$a" = ".$(cat "$dir/$b")" ] || fail "$cmd" missing or wrong file "$b";;
+	DIR)	[ -d "$dir/$a" ] || fail "$cmd" missing directory "$a";;
+	CALLS)	n="$(count "$a")"; [ "$n" -eq "$b" ] || fail "$cmd" "$n" calls of "$a", expected "$b";;
+	BUDGET)	n="$(count "$a")"; [ "$n" -le "$b" ] || fail "$cmd" "$n" calls of "$a", budget is "$b";;
+	*)	OOPS "$NAME:$lineno:" unknown command "$cmd";;
+	esac
+done < "$TESTS"
+end
+
+[ 0 = "$fails" ] && exit
+printf 'syscount: %d tests, %d failures\n' "$tests" "$fails" >&2
+exit 1